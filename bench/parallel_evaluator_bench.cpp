@@ -0,0 +1,114 @@
+// Последовательное вычисление скрипта против ParallelEvaluator.
+// Запуск: ./build/parallel_evaluator_bench [потоки] [итерации]
+// Для каждой длины скрипта печатает время обоих путей; по нему выбирается
+// ParallelConfig::min_statements.
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Calculator.h"
+#include "../include/Lexer.h"
+#include "../include/ParallelEvaluator.h"
+#include "../include/ResponseWriter.h"
+#include "../include/VariableStore.h"
+
+using namespace calcserver;
+using Clock = std::chrono::steady_clock;
+
+struct Script {
+    std::string text;
+    std::vector<Statement> statements;
+    std::vector<Token> tokens;
+    std::vector<Token> parallel_tokens;   // ParallelEvaluator пишет в токены id переменных
+};
+
+// Независимые операторы a_i = f(x, y) — лучший случай для графа
+static std::unique_ptr<Script> make_independent(size_t count) {
+    auto script = std::make_unique<Script>();
+    for (size_t i = 0; i < count; ++i) {
+        script->text += "a_" + std::to_string(i) + " = x * y + x - y / 2; ";
+    }
+    Lexer lexer(script->text);
+    Statement stmt;
+    while (lexer.next(stmt, script->tokens)) script->statements.push_back(stmt);
+    script->parallel_tokens = script->tokens;
+    return script;
+}
+
+// Повторяет ExpressionHandler::evaluate_sequential
+static void evaluate_sequential(const Script& script, VariableStore& vars, ResponseWriter& response) {
+    Calculator calc;
+    for (const Statement& stmt : script.statements) {
+        double result = calc.calculate(script.tokens.data() + stmt.first,
+                                       script.tokens.data() + stmt.last, vars);
+        if (calc.was_assignment()) {
+            response.add_assignment(calc.get_last_var(), result);
+        } else {
+            response.add_value(result);
+        }
+    }
+}
+
+template <typename Fn>
+static double measure_us(int iterations, Fn&& fn) {
+    fn();
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) fn();
+    std::chrono::duration<double, std::micro> elapsed = Clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+    size_t threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 20;
+    if (threads < 2) threads = 2;
+
+    ParallelEvaluator parallel(std::make_shared<ThreadPool>(threads));
+    ResponseWriter writer;
+
+    std::cout << "threads: " << threads
+              << ", hardware_concurrency: " << std::thread::hardware_concurrency() << "\n"
+              << "statements   sequential us   parallel us   parallel/sequential\n";
+
+    for (size_t count : {16, 64, 256, 1024, 4096, 20000}) {
+        auto script = make_independent(count);
+        int runs = std::max(1, static_cast<int>(iterations * 20000 / count));
+
+        // Сессия на каждый путь живёт между итерациями, как у постоянного
+        // пользователя: имена регистрируются в первом прогоне
+        VariableStore sequential_vars;
+        VariableStore parallel_vars;
+
+        auto run = [&](bool use_parallel) {
+            VariableStore& vars = use_parallel ? parallel_vars : sequential_vars;
+            vars["x"] = 3;
+            vars["y"] = 4;
+            writer.clear();
+            writer.begin_results();
+            if (use_parallel) {
+                parallel.evaluate(script->statements, script->parallel_tokens, vars, writer);
+            } else {
+                evaluate_sequential(*script, vars, writer);
+            }
+            writer.end_results();
+        };
+
+        // Проверка совместимости: оба пути дают один и тот же ответ
+        run(false);
+        std::string expected = writer.str();
+        run(true);
+        if (writer.str() != expected) {
+            std::cerr << "Ответы различаются при " << count << " операторах\n";
+            return 1;
+        }
+
+        double sequential_us = measure_us(runs, [&] { run(false); });
+        double parallel_us = measure_us(runs, [&] { run(true); });
+        std::cout << count << "\t\t" << sequential_us << "\t\t" << parallel_us
+                  << "\t\t" << parallel_us / sequential_us << "\n";
+    }
+    return 0;
+}
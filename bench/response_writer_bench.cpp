@@ -0,0 +1,97 @@
+// Сравнение сериализации ответа: json DOM + dump() против ResponseWriter.
+// Запуск: ./build/response_writer_bench [количество результатов] [итерации]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "../include/ResponseWriter.h"
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    std::string var;   // пусто — обычное выражение
+    double value;
+};
+
+static std::vector<Result> make_results(size_t count) {
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> dist(-1e6, 1e6);
+    std::vector<Result> results;
+    results.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 2 == 0) {
+            results.push_back({"a_" + std::to_string(i), dist(rng)});
+        } else {
+            results.push_back({"", i % 3 == 0 ? static_cast<double>(i) : dist(rng)});
+        }
+    }
+    return results;
+}
+
+static std::string serialize_dom(const std::vector<Result>& results) {
+    json array = json::array();
+    for (const auto& r : results) {
+        if (r.var.empty()) {
+            array.push_back(r.value);
+        } else {
+            array.push_back({{r.var, r.value}});
+        }
+    }
+    json response;
+    response["res"] = array;
+    return response.dump();
+}
+
+static const std::string& serialize_writer(calcserver::ResponseWriter& writer,
+                                           const std::vector<Result>& results) {
+    writer.clear();
+    writer.begin_results();
+    for (const auto& r : results) {
+        if (r.var.empty()) {
+            writer.add_value(r.value);
+        } else {
+            writer.add_assignment(r.var, r.value);
+        }
+    }
+    writer.end_results();
+    return writer.str();
+}
+
+template <typename Fn>
+static double measure_us(int iterations, Fn&& fn) {
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) fn();
+    std::chrono::duration<double, std::micro> elapsed = Clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    auto results = make_results(count);
+    calcserver::ResponseWriter writer;
+
+    // Проверка совместимости: ответы должны разбираться в одно и то же
+    std::string dom = serialize_dom(results);
+    std::string fast = serialize_writer(writer, results);
+    if (json::parse(dom) != json::parse(fast)) {
+        std::cerr << "Ответы различаются\n";
+        return 1;
+    }
+
+    size_t sink = 0;
+    double dom_us = measure_us(iterations, [&] { sink += serialize_dom(results).size(); });
+    double writer_us = measure_us(iterations, [&] { sink += serialize_writer(writer, results).size(); });
+
+    std::cout << "results: " << count << ", body: " << fast.size() << " bytes\n"
+              << "json dump:      " << dom_us << " us/response\n"
+              << "ResponseWriter: " << writer_us << " us/response\n"
+              << "speedup:        " << dom_us / writer_us << "x\n"
+              << "(checksum " << sink << ")\n";
+    return 0;
+}
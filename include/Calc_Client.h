@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <httplib.h>
 #include <nlohmann/json.hpp>
+#include "Compression.h"
 
 namespace calcclient {
 
@@ -20,6 +21,23 @@ namespace calcclient {
         virtual void execute() = 0;
     };
 
+    // Клиент с поддержкой сжатых ответов; распаковка — через compression::decompress
+    inline httplib::Client make_client() {
+        httplib::Client cli("localhost", 8080);
+        cli.set_connection_timeout(3);
+        cli.set_decompress(false);
+        return cli;
+    }
+
+    inline httplib::Result post_request(httplib::Client& cli, const json& req) {
+        httplib::Headers headers = {{"Accept-Encoding", compression::accepted_encodings()}};
+        auto res = cli.Post("/api/calculate", headers, req.dump(), "application/json");
+        if (res) {
+            res->body = compression::decompress(res->get_header_value("Content-Encoding"), res->body);
+        }
+        return res;
+    }
+
     class CommandException : public std::exception {
         std::string message_;
     public:
@@ -43,8 +61,7 @@ namespace calcclient {
             : expression_(expr), user_(user) {}
 
         void execute() override {
-            httplib::Client cli("localhost", 8080);
-            cli.set_connection_timeout(3);
+            auto cli = make_client();
 
             // Обработка спецсимволов и формирование запроса
             std::string processed_expr = expression_;
@@ -54,7 +71,7 @@ namespace calcclient {
             req["exp"] = expression_;
             if (!user_.empty()) req["user"] = user_;
 
-            if (auto res = cli.Post("/api/calculate", req.dump(), "application/json")) {
+            if (auto res = post_request(cli, req)) {
                 handle_response(*res);
             } else {
                 throw CommandException("Ошибка соединения: " + httplib::to_string(res.error()));
@@ -88,14 +105,13 @@ namespace calcclient {
         CleanCommand(const std::string& user) : user_(user) {}
 
         void execute() override {
-            httplib::Client cli("localhost", 8080);
-            cli.set_connection_timeout(3);
+            auto cli = make_client();
 
             json req;
             req["cmd"] = "clean";
             if (!user_.empty()) req["user"] = user_;
 
-            if (auto res = cli.Post("/api/calculate", req.dump(), "application/json")) {
+            if (auto res = post_request(cli, req)) {
                 if (res->status == 200) {
                     std::cout << "Сессия пользователя '" << user_ << "' очищена\n";
                 } else {
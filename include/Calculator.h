@@ -1,10 +1,11 @@
 #pragma once
+#include "Lexer.h"
 #include "Token.h"
-#include <queue>
-#include <map>
-#include <sstream>
+#include "VariableStore.h"
 #include <stdexcept>
-#include <cctype>
+#include <string>
+#include <string_view>
+#include <vector>
 
 class Calculator {
 public:
@@ -14,120 +15,108 @@ public:
         return (start == std::string::npos) ? "" : s.substr(start, end - start + 1);
     }
 
-    double calculate(const std::string& expr, std::map<std::string, double>& vars) {
-        auto tokens = tokenize(expr);
-        bool is_assignment = process_assignments(tokens, vars);
-        
+    double calculate(std::string_view expr, VariableStore& vars) {
+        tokens_.clear();
+        Lexer::tokenize(expr, tokens_);
+        return calculate(tokens_.data(), tokens_.data() + tokens_.size(), vars);
+    }
+
+    // Вычисление уже разобранного оператора (см. Lexer)
+    double calculate(const Token* begin, const Token* end, VariableStore& vars) {
+        last_assigned_var_ = kNoSymbol;
+        bool is_assignment = process_assignments(begin, end, vars);
+
         if (is_assignment) {
             return vars[last_assigned_var_];
         } else {
-            auto postfix = shunting_yard(tokens);
-            return evaluate(postfix, vars);
+            shunting_yard(begin, end, vars.symbols());
+            return evaluate(vars);
         }
     }
 
-    bool was_assignment() const { return !last_assigned_var_.empty(); }
-    std::string get_last_var() const { return last_assigned_var_; }
-
-private:
-    std::string last_assigned_var_;
-
-    std::queue<Token> tokenize(const std::string& expr) {
-        std::queue<Token> tokens;
-        std::string buffer;
-        bool negative = false;
-
-        for (size_t i = 0; i < expr.size(); ++i) {
-            char c = expr[i];
-
-            if (isdigit(c) || c == '.' || (c == '-' && (i == 0 || expr[i-1] == '('))) {
-                if (c == '-' && (i == 0 || expr[i-1] == '(')) {
-                    negative = true;
-                    continue;
-                }
-                buffer += c;
-            } else {
-                if (!buffer.empty()) {
-                    handle_buffer(buffer, negative, tokens);
-                    buffer.clear();
-                    negative = false;
-                }
-
-                if (c == ' ') continue;
-
-                switch(c) {
-                    case '+': case '-': case '*': case '/': 
-                        tokens.emplace(c); break;
-                    case '(': tokens.emplace(TokenType::LeftParen); break;
-                    case ')': tokens.emplace(TokenType::RightParen); break;
-                    case '=': tokens.emplace(TokenType::Assignment); break;
-                    default:
-                        if (isalpha(c)) {
-                            std::string var;
-                            while (i < expr.size() && (isalnum(expr[i]) || expr[i] == '_')) {
-                                var += expr[i++];
-                            }
-                            i--;
-                            tokens.emplace(var);
-                        } else {
-                            throw std::runtime_error("Invalid character: " + std::string(1, c));
-                        }
-                }
+    bool was_assignment() const { return last_assigned_var_ != kNoSymbol; }
+    std::string_view get_last_var() const { return last_assigned_name_; }
+    SymbolId get_last_symbol() const { return last_assigned_var_; }
+
+    // Разбирает оператор без вычисления: сохраняет в токенах id переменных,
+    // уже известных таблице, чтобы calculate() их не искал повторно.
+    // Имена только ищутся, неизвестные остаются kNoSymbol. Возвращает true
+    // для присваивания.
+    static bool analyze(Token* begin, Token* end, const SymbolTable& symbols) {
+        bool assignment = is_assignment(begin, end);
+        for (; begin != end; ++begin) {
+            if (begin->type == TokenType::Variable) {
+                begin->symbol = symbols.lookup(begin->variable_name);
             }
         }
+        return assignment;
+    }
 
-        if (!buffer.empty()) handle_buffer(buffer, negative, tokens);
-        return tokens;
+private:
+    SymbolId last_assigned_var_ = kNoSymbol;
+    std::string_view last_assigned_name_;
+
+    // Буферы переиспользуются между вызовами
+    std::vector<Token> tokens_;
+    std::vector<Token> postfix_;
+    std::vector<Token> ops_;
+    std::vector<double> stack_;
+
+    // Читаемые имена только ищутся: неизвестное имя не может быть в сессии
+    static SymbolId resolve(const Token& token, const SymbolTable& symbols) {
+        return token.symbol != kNoSymbol ? token.symbol : symbols.lookup(token.variable_name);
     }
 
-    void handle_buffer(std::string& buffer, bool negative, std::queue<Token>& tokens) {
-        double num = stod(buffer);
-        if (negative) num = -num;
-        tokens.emplace(num);
+    static bool is_assignment(const Token* begin, const Token* end) {
+        return end - begin >= 3 &&
+               begin[0].type == TokenType::Variable &&
+               begin[1].type == TokenType::Assignment;
     }
 
-    std::queue<Token> shunting_yard(std::queue<Token> tokens) {
-        std::queue<Token> output;
-        std::stack<Token> ops;
+    void shunting_yard(const Token* begin, const Token* end, const SymbolTable& symbols) {
+        postfix_.clear();
+        ops_.clear();
 
-        while (!tokens.empty()) {
-            Token token = tokens.front();
-            tokens.pop();
+        for (const Token* it = begin; it != end; ++it) {
+            const Token& token = *it;
 
             switch(token.type) {
                 case TokenType::Number:
+                    postfix_.push_back(token); break;
+
                 case TokenType::Variable:
-                    output.push(token); break;
+                    postfix_.push_back(token);
+                    postfix_.back().symbol = resolve(token, symbols);
+                    break;
 
                 case TokenType::Operator:
-                    while (!ops.empty() && is_higher_precedence(ops.top(), token)) {
-                        output.push(ops.top());
-                        ops.pop();
+                    while (!ops_.empty() && is_higher_precedence(ops_.back(), token)) {
+                        postfix_.push_back(ops_.back());
+                        ops_.pop_back();
                     }
-                    ops.push(token);
+                    ops_.push_back(token);
                     break;
 
                 case TokenType::LeftParen:
-                    ops.push(token); break;
+                    ops_.push_back(token); break;
 
                 case TokenType::RightParen:
-                    while (!ops.empty() && ops.top().type != TokenType::LeftParen) {
-                        output.push(ops.top());
-                        ops.pop();
+                    while (!ops_.empty() && ops_.back().type != TokenType::LeftParen) {
+                        postfix_.push_back(ops_.back());
+                        ops_.pop_back();
                     }
-                    if (ops.empty()) throw std::runtime_error("Mismatched parentheses");
-                    ops.pop();
+                    if (ops_.empty()) throw std::runtime_error("Mismatched parentheses");
+                    ops_.pop_back();
                     break;
 
                 default: break;
             }
         }
 
-        while (!ops.empty()) {
-            output.push(ops.top());
-            ops.pop();
+        while (!ops_.empty()) {
+            postfix_.push_back(ops_.back());
+            ops_.pop_back();
         }
-        return output;
     }
 
     bool is_higher_precedence(const Token& op1, const Token& op2) {
@@ -136,83 +125,66 @@ private:
                (op2.operator_symbol == '+' || op2.operator_symbol == '-');
     }
 
-    bool process_assignments(std::queue<Token>& tokens, std::map<std::string, double>& vars) {
-        if (tokens.size() < 3) return false;
-        
-        // Сохраняем исходные токены для восстановления в случае ошибки
-        std::queue<Token> original_tokens = tokens;
-        
-        try {
-            Token var_token = tokens.front();
-            if (var_token.type != TokenType::Variable) return false;
-            std::string var = var_token.variable_name;
-            tokens.pop();
-
-            if (tokens.front().type != TokenType::Assignment) {
-                tokens = original_tokens;
-                return false;
-            }
-            tokens.pop();
+    bool process_assignments(const Token* begin, const Token* end, VariableStore& vars) {
+        if (!is_assignment(begin, end)) return false;
 
-            if (tokens.empty()) {
-                throw std::runtime_error("Missing value after assignment");
-            }
+        try {
+            shunting_yard(begin + 2, end, vars.symbols());
+            double value = evaluate(vars);
 
-            auto postfix = shunting_yard(tokens);
-            double value = evaluate(postfix, vars);
+            // Имя регистрируется только после успешного вычисления, чтобы
+            // ошибочные присваивания не оставляли имён в таблице сессии
+            SymbolId var = begin->symbol != kNoSymbol ? begin->symbol
+                                                      : vars.symbols().intern(begin->variable_name);
             vars[var] = value;
             last_assigned_var_ = var;
-            tokens = {}; // Полностью очищаем токены
+            last_assigned_name_ = begin->variable_name;
             return true;
 
         } catch (...) {
-            tokens = original_tokens; // Восстанавливаем исходные токены
-            last_assigned_var_.clear();
+            last_assigned_var_ = kNoSymbol;
             throw;
         }
     }
 
-    double evaluate(std::queue<Token> postfix, std::map<std::string, double>& vars) {
-        std::stack<double> stack;
-        
-        while (!postfix.empty()) {
-            Token token = postfix.front();
-            postfix.pop();
+    double evaluate(const VariableStore& vars) {
+        stack_.clear();
 
+        for (Token& token : postfix_) {
             switch(token.type) {
                 case TokenType::Number:
-                    stack.push(token.number_value); break;
-                    
+                    stack_.push_back(token.number_value); break;
+
                 case TokenType::Variable: {
-                    auto it = vars.find(token.variable_name);
-                    if (it == vars.end()) {
-                        throw std::runtime_error("Undefined variable: " + token.variable_name);
+                    const double* value = vars.find(token.symbol);
+                    if (!value) {
+                        throw std::runtime_error("Undefined variable: " + std::string(token.variable_name));
                     }
-                    stack.push(it->second);
+                    stack_.push_back(*value);
                     break;
                 }
-                    
+
                 case TokenType::Operator: {
-                    if (stack.size() < 2) throw std::runtime_error("Not enough operands");
-                    double b = stack.top(); stack.pop();
-                    double a = stack.top(); stack.pop();
-                    
+                    if (stack_.size() < 2) throw std::runtime_error("Not enough operands");
+                    double b = stack_.back(); stack_.pop_back();
+                    double a = stack_.back(); stack_.pop_back();
+
                     switch(token.operator_symbol) {
-                        case '+': stack.push(a + b); break;
-                        case '-': stack.push(a - b); break;
-                        case '*': stack.push(a * b); break;
-                        case '/': 
+                        case '+': stack_.push_back(a + b); break;
+                        case '-': stack_.push_back(a - b); break;
+                        case '*': stack_.push_back(a * b); break;
+                        case '/':
                             if (b == 0) throw std::runtime_error("Division by zero");
-                            stack.push(a / b); break;
+                            stack_.push_back(a / b); break;
                     }
                     break;
                 }
-                
+
                 default: break;
             }
         }
-        
-        if (stack.size() != 1) throw std::runtime_error("Invalid expression");
-        return stack.top();
+
+        if (stack_.size() != 1) throw std::runtime_error("Invalid expression");
+        return stack_.back();
     }
-};
\ No newline at end of file
+};
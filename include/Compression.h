@@ -0,0 +1,269 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <zlib.h>
+#ifdef CALC_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// Сжатие тел ответов и их распаковка на клиенте. Используется вместо
+// встроенного сжатия httplib, чтобы контексты компрессоров жили в потоках
+// и не создавались на каждый запрос. Встроенное сжатие выключено в
+// CmakeLists.txt (HTTPLIB_USE_ZLIB_IF_AVAILABLE): с ним httplib сжал бы
+// уже сжатое тело ещё раз.
+namespace compression {
+
+enum class Encoding {
+    Identity,
+    Gzip,
+    Zstd
+};
+
+struct CompressionConfig {
+    bool enabled = true;
+    size_t min_size = 4096;   // Тела короче отдаются без сжатия
+    int gzip_level = 6;       // 1..9
+    int zstd_level = 3;       // 1..19
+};
+
+// Проверяется при создании сервиса: неверный уровень иначе всплыл бы
+// ошибкой сжатия на каждом крупном ответе
+inline void validate(const CompressionConfig& config) {
+    if (config.gzip_level < 1 || config.gzip_level > 9) {
+        throw std::invalid_argument("gzip_level must be in 1..9");
+    }
+    if (config.zstd_level < 1 || config.zstd_level > 19) {
+        throw std::invalid_argument("zstd_level must be in 1..19");
+    }
+}
+
+// Названия кодировок сравниваются без учёта регистра (RFC 9110, 8.4.1)
+inline bool iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x)) ==
+                      std::tolower(static_cast<unsigned char>(y));
+           });
+}
+
+inline const char* encoding_name(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::Gzip: return "gzip";
+        case Encoding::Zstd: return "zstd";
+        default: return "identity";
+    }
+}
+
+// Значение Accept-Encoding для клиента
+inline const char* accepted_encodings() {
+#ifdef CALC_HAVE_ZSTD
+    return "zstd, gzip";
+#else
+    return "gzip";
+#endif
+}
+
+// Выбор кодировки по Accept-Encoding: наибольший q, при равенстве — zstd.
+// q=0 запрещает кодировку, "*" разрешает любую доступную.
+inline Encoding negotiate(std::string_view accept_encoding) {
+    // -1 — кодировка не упомянута
+    double gzip_q = -1;
+    double zstd_q = -1;
+    double any_q = 0;
+
+    while (!accept_encoding.empty()) {
+        size_t comma = accept_encoding.find(',');
+        std::string_view item = accept_encoding.substr(0, comma);
+        accept_encoding = comma == std::string_view::npos ? std::string_view()
+                                                          : accept_encoding.substr(comma + 1);
+
+        double q = 1.0;
+        size_t semicolon = item.find(';');
+        if (semicolon != std::string_view::npos) {
+            std::string_view params = item.substr(semicolon + 1);
+            size_t q_pos = params.find("q=");
+            if (q_pos != std::string_view::npos) {
+                q = std::strtod(std::string(params.substr(q_pos + 2)).c_str(), nullptr);
+            }
+            item = item.substr(0, semicolon);
+        }
+
+        while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+        while (!item.empty() && item.back() == ' ') item.remove_suffix(1);
+
+        if (iequals(item, "gzip") || iequals(item, "x-gzip")) gzip_q = q;
+        else if (iequals(item, "zstd")) zstd_q = q;
+        else if (item == "*") any_q = q;
+    }
+
+    if (gzip_q < 0) gzip_q = any_q;
+    if (zstd_q < 0) zstd_q = any_q;
+
+#ifdef CALC_HAVE_ZSTD
+    if (zstd_q > 0 && zstd_q >= gzip_q) return Encoding::Zstd;
+#endif
+    if (gzip_q > 0) return Encoding::Gzip;
+    return Encoding::Identity;
+}
+
+// =============================================
+// Per-thread compressor contexts
+// =============================================
+class GzipCompressor {
+    z_stream stream_{};
+    int level_ = -1;
+
+public:
+    GzipCompressor() = default;
+    ~GzipCompressor() { if (level_ >= 0) deflateEnd(&stream_); }
+
+    GzipCompressor(const GzipCompressor&) = delete;
+    GzipCompressor& operator=(const GzipCompressor&) = delete;
+
+    static GzipCompressor& local() {
+        thread_local GzipCompressor compressor;
+        return compressor;
+    }
+
+    void compress(std::string_view input, std::string& out, int level) {
+        prepare(level);
+
+        out.resize(deflateBound(&stream_, static_cast<uLong>(input.size())));
+        stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        stream_.avail_in = static_cast<uInt>(input.size());
+        stream_.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        stream_.avail_out = static_cast<uInt>(out.size());
+
+        if (deflate(&stream_, Z_FINISH) != Z_STREAM_END) {
+            throw std::runtime_error("gzip compression failed");
+        }
+        out.resize(stream_.total_out);
+    }
+
+private:
+    void prepare(int level) {
+        if (level_ == level) {
+            deflateReset(&stream_);
+            return;
+        }
+        if (level_ >= 0) deflateEnd(&stream_);
+        stream_ = z_stream{};
+        // 15 + 16: окно 32 КБ и gzip-обёртка
+        if (deflateInit2(&stream_, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            level_ = -1;
+            throw std::runtime_error("gzip initialization failed");
+        }
+        level_ = level;
+    }
+};
+
+#ifdef CALC_HAVE_ZSTD
+class ZstdCompressor {
+    ZSTD_CCtx* context_ = ZSTD_createCCtx();
+
+public:
+    ZstdCompressor() = default;
+    ~ZstdCompressor() { ZSTD_freeCCtx(context_); }
+
+    ZstdCompressor(const ZstdCompressor&) = delete;
+    ZstdCompressor& operator=(const ZstdCompressor&) = delete;
+
+    static ZstdCompressor& local() {
+        thread_local ZstdCompressor compressor;
+        return compressor;
+    }
+
+    void compress(std::string_view input, std::string& out, int level) {
+        out.resize(ZSTD_compressBound(input.size()));
+        size_t size = ZSTD_compressCCtx(context_, &out[0], out.size(),
+                                        input.data(), input.size(), level);
+        if (ZSTD_isError(size)) {
+            throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(size));
+        }
+        out.resize(size);
+    }
+};
+#endif
+
+inline void compress(Encoding encoding, std::string_view input, std::string& out,
+                     const CompressionConfig& config) {
+    switch (encoding) {
+        case Encoding::Gzip:
+            GzipCompressor::local().compress(input, out, config.gzip_level);
+            break;
+#ifdef CALC_HAVE_ZSTD
+        case Encoding::Zstd:
+            ZstdCompressor::local().compress(input, out, config.zstd_level);
+            break;
+#endif
+        default:
+            out.assign(input.data(), input.size());
+    }
+}
+
+// =============================================
+// Decompression (client side)
+// =============================================
+inline std::string decompress(std::string_view content_encoding, std::string_view input) {
+    if (content_encoding.empty() || iequals(content_encoding, "identity")) {
+        return std::string(input);
+    }
+
+    std::string out;
+    if (iequals(content_encoding, "gzip") || iequals(content_encoding, "x-gzip")) {
+        z_stream stream{};
+        // 15 + 32: автоопределение gzip/zlib-заголовка
+        if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+            throw std::runtime_error("gzip initialization failed");
+        }
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        stream.avail_in = static_cast<uInt>(input.size());
+
+        int status = Z_OK;
+        while (status != Z_STREAM_END) {
+            size_t offset = out.size();
+            out.resize(offset + std::max<size_t>(input.size() * 4, 16384));
+            stream.next_out = reinterpret_cast<Bytef*>(&out[offset]);
+            stream.avail_out = static_cast<uInt>(out.size() - offset);
+
+            status = inflate(&stream, Z_NO_FLUSH);
+            if (status != Z_OK && status != Z_STREAM_END) {
+                inflateEnd(&stream);
+                throw std::runtime_error("Invalid gzip response body");
+            }
+            out.resize(out.size() - stream.avail_out);
+        }
+        inflateEnd(&stream);
+        return out;
+    }
+
+#ifdef CALC_HAVE_ZSTD
+    if (iequals(content_encoding, "zstd")) {
+        ZSTD_DStream* stream = ZSTD_createDStream();
+        ZSTD_inBuffer in{input.data(), input.size(), 0};
+        size_t status = 1;
+        while (status != 0) {
+            size_t offset = out.size();
+            out.resize(offset + ZSTD_DStreamOutSize());
+            ZSTD_outBuffer buffer{&out[offset], out.size() - offset, 0};
+
+            status = ZSTD_decompressStream(stream, &buffer, &in);
+            out.resize(offset + buffer.pos);
+            if (ZSTD_isError(status) || (status != 0 && in.pos == in.size && buffer.pos == 0)) {
+                ZSTD_freeDStream(stream);
+                throw std::runtime_error("Invalid zstd response body");
+            }
+        }
+        ZSTD_freeDStream(stream);
+        return out;
+    }
+#endif
+
+    throw std::runtime_error("Unsupported Content-Encoding: " + std::string(content_encoding));
+}
+
+} // namespace compression
@@ -0,0 +1,149 @@
+#pragma once
+#include "Token.h"
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Оператор скрипта: текст без крайних пробелов и диапазон его токенов
+// в общем буфере. Ошибка разбора не бросается сразу, а сохраняется и
+// выдаётся при выполнении оператора, как при прежнем построчном разборе.
+struct Statement {
+    std::string_view text;
+    size_t first = 0;
+    size_t last = 0;
+    std::string error;
+};
+
+// =============================================
+// Lexer
+// =============================================
+// Один проход по всему скрипту: границы операторов (';'), числа через
+// std::from_chars, имена переменных — string_view в исходный текст.
+// Промежуточных строк не создаётся, поэтому текст должен пережить токены.
+class Lexer {
+    std::string_view src_;
+    size_t pos_ = 0;
+
+public:
+    explicit Lexer(std::string_view src) : src_(src) {}
+
+    // Дописывает токены следующего непустого оператора в tokens.
+    // Возвращает false, когда операторы закончились.
+    bool next(Statement& stmt, std::vector<Token>& tokens) {
+        while (pos_ < src_.size()) {
+            size_t begin = pos_;
+            while (begin < src_.size() && src_[begin] == ' ') ++begin;
+
+            stmt.first = tokens.size();
+            stmt.error.clear();
+            size_t end = scan(begin, tokens, stmt.error);
+            pos_ = end < src_.size() ? end + 1 : end;
+
+            size_t last = end;
+            while (last > begin && src_[last - 1] == ' ') --last;
+            if (last == begin) continue;
+
+            stmt.text = src_.substr(begin, last - begin);
+            stmt.last = tokens.size();
+            return true;
+        }
+        return false;
+    }
+
+    // Разбор одиночного выражения; ошибка бросается сразу
+    static void tokenize(std::string_view expr, std::vector<Token>& tokens) {
+        Lexer lexer(expr);
+        size_t begin = 0;
+        while (begin < expr.size() && expr[begin] == ' ') ++begin;
+        lexer.scan_statement(begin, false, tokens);
+    }
+
+private:
+    // Возвращает позицию ';', завершающей оператор, или конец текста
+    size_t scan(size_t begin, std::vector<Token>& tokens, std::string& error) {
+        size_t first = tokens.size();
+        try {
+            return scan_statement(begin, true, tokens);
+        } catch (const std::exception& e) {
+            error = e.what();
+            tokens.erase(tokens.begin() + first, tokens.end());
+            size_t end = src_.find(';', begin);
+            return end == std::string_view::npos ? src_.size() : end;
+        }
+    }
+
+    size_t scan_statement(size_t begin, bool split, std::vector<Token>& tokens) {
+        size_t number_start = std::string_view::npos;
+        bool negative = false;
+        size_t end = src_.size();
+
+        for (size_t i = begin; i < src_.size(); ++i) {
+            char c = src_[i];
+            if (split && c == ';') {
+                end = i;
+                break;
+            }
+            bool unary = c == '-' && (i == begin || src_[i - 1] == '(');
+
+            if (isdigit(static_cast<unsigned char>(c)) || c == '.' || unary) {
+                if (unary) {
+                    negative = true;
+                    continue;
+                }
+                if (number_start == std::string_view::npos) number_start = i;
+                continue;
+            }
+
+            if (number_start != std::string_view::npos) {
+                push_number(number_start, i, negative, tokens);
+                number_start = std::string_view::npos;
+                negative = false;
+            }
+
+            if (c == ' ') continue;
+
+            switch (c) {
+                case '+': case '-': case '*': case '/':
+                    tokens.emplace_back(c); break;
+                case '(': tokens.emplace_back(TokenType::LeftParen); break;
+                case ')': tokens.emplace_back(TokenType::RightParen); break;
+                case '=': tokens.emplace_back(TokenType::Assignment); break;
+                default:
+                    if (isalpha(static_cast<unsigned char>(c))) {
+                        size_t start = i;
+                        while (i < src_.size() && (isalnum(static_cast<unsigned char>(src_[i])) || src_[i] == '_')) ++i;
+                        tokens.emplace_back(src_.substr(start, i - start));
+                        --i;
+                    } else {
+                        throw std::runtime_error("Invalid character: " + std::string(1, c));
+                    }
+            }
+        }
+
+        if (number_start != std::string_view::npos) push_number(number_start, end, negative, tokens);
+        return end;
+    }
+
+    void push_number(size_t start, size_t end, bool negative, std::vector<Token>& tokens) {
+        double value = 0;
+        auto [ptr, ec] = std::from_chars(src_.data() + start, src_.data() + end, value);
+        if (ec == std::errc::invalid_argument) {
+            throw std::runtime_error("Invalid number: " + preview(start, end));
+        }
+        if (ec == std::errc::result_out_of_range) {
+            throw std::runtime_error("Number out of range: " + preview(start, end));
+        }
+        tokens.emplace_back(negative ? -value : value);
+    }
+
+    // Начало литерала для текста ошибки: сам литерал может занимать
+    // мегабайты, а сообщение уходит в JSON-ответ
+    std::string preview(size_t start, size_t end) const {
+        constexpr size_t kMaxPreview = 32;
+        if (end - start <= kMaxPreview) return std::string(src_.substr(start, end - start));
+        return std::string(src_.substr(start, kMaxPreview)) + "...";
+    }
+};
@@ -0,0 +1,318 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Calculator.h"
+#include "Lexer.h"
+#include "ResponseWriter.h"
+#include "ThreadPool.h"
+#include "Tracer.h"
+#include "VariableStore.h"
+
+namespace calcserver {
+
+// Оценка порога по bench/parallel_evaluator_bench: последовательный проход
+// стоит ~0.5 мкс на оператор, из них ~0.2 мкс (связывание графа и применение
+// результатов) остаются последовательными и в параллельном режиме, запуск
+// стоит до ~70 мкс. Замеры есть только с одного ядра, поэтому режим по
+// умолчанию выключен: threads и min_statements задаются после замера на
+// целевой машине.
+struct ParallelConfig {
+    size_t min_statements = 1024;                             // Меньшие скрипты считаются последовательно
+    size_t threads = 0;                                       // 0 или 1 — параллельный режим выключен
+};
+
+// =============================================
+// Dependency-aware script evaluation
+// =============================================
+// Строит граф зависимостей между операторами скрипта по читаемым и
+// присваиваемым переменным и вычисляет независимые операторы параллельно.
+// Каждое присваивание получает свою версию переменной, поэтому рёбра нужны
+// только для пары "запись -> чтение". Сессия не меняется до конца
+// вычисления: результаты применяются по порядку вплоть до первой ошибки,
+// что даёт то же состояние, ответ и текст ошибки, что и последовательный
+// проход. Имена, зарегистрированные операторами после ошибки, убираются
+// из таблицы сессии.
+class ParallelEvaluator {
+    static constexpr size_t kNoError = std::numeric_limits<size_t>::max();
+    static constexpr size_t kFromSession = std::numeric_limits<size_t>::max();
+
+    struct Input {
+        SymbolId symbol;
+        size_t source = kFromSession;   // Оператор-источник значения
+        double value = 0;               // Значение из сессии
+        bool present = false;           // Есть ли переменная в сессии
+    };
+
+    struct Node {
+        const Statement* stmt = nullptr;
+        SymbolId target = kNoSymbol;
+        bool assigns = false;
+        size_t symbols_before = 0;      // Размер таблицы имён до этого оператора
+        size_t first_input = 0;         // Диапазон входов в Run::inputs
+        size_t last_input = 0;
+        std::vector<size_t> dependents;
+        std::atomic<size_t> pending{0};
+        std::atomic<bool> blocked{false};
+        double value = 0;
+        std::string error;
+    };
+
+    // Счётчик незавершённой работы; wait() возвращается, когда он дошёл до нуля
+    struct Latch {
+        std::atomic<size_t> count{0};
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool done = false;
+
+        void count_down(size_t n = 1) {
+            if (count.fetch_sub(n, std::memory_order_acq_rel) != n) return;
+            std::lock_guard<std::mutex> lock(mtx);
+            done = true;
+            cv.notify_one();
+        }
+
+        void wait() {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this] { return done; });
+        }
+    };
+
+    struct Run {
+        std::vector<Node> nodes;
+        std::vector<Input> inputs;
+        Token* tokens = nullptr;
+        Latch analyzed;
+        Latch executed;
+        std::atomic<size_t> first_error{kNoError};
+        TraceContext trace;
+    };
+
+    std::shared_ptr<ThreadPool> pool_;
+
+public:
+    explicit ParallelEvaluator(std::shared_ptr<ThreadPool> pool) : pool_(std::move(pool)) {}
+
+    // Анализ записывает в tokens id переменных из таблицы имён vars
+    void evaluate(const std::vector<Statement>& statements,
+                  std::vector<Token>& tokens,
+                  VariableStore& vars,
+                  ResponseWriter& response)
+    {
+        Run run;
+        run.tokens = tokens.data();
+        run.nodes = std::vector<Node>(statements.size());
+        run.analyzed.count.store(statements.size(), std::memory_order_relaxed);
+        run.executed.count.store(statements.size(), std::memory_order_relaxed);
+        run.trace = Tracer::current();
+
+        std::vector<size_t> roots;
+        {
+            TraceSpan span("dependency_analysis", static_cast<int64_t>(statements.size()));
+
+            // Поиск известных имён не зависит от порядка и идёт на пуле; новые
+            // имена регистрируются и связи "запись -> чтение" строятся одним
+            // проходом по порядку
+            const SymbolTable& symbols = vars.symbols();
+            for_each_chunk(run, statements.size(), [&run, &statements, &symbols](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) analyze_node(run, statements, symbols, i);
+                run.analyzed.count_down(end - begin);
+            });
+            run.analyzed.wait();
+            link_graph(run, vars, roots);
+        }
+
+        // Корни раздаются пачками, остальное планируется по мере готовности
+        for_each_chunk(run, roots.size(), [this, &run, &roots](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) execute(run, roots[i]);
+        });
+        run.executed.wait();
+
+        size_t failed = run.first_error.load(std::memory_order_acquire);
+        size_t committed = std::min(failed, run.nodes.size());
+        {
+            // Применение к сессии и запись ответа идут по порядку, вне "calculate"
+            TraceSpan span("commit", static_cast<int64_t>(committed));
+            for (size_t i = 0; i < committed; ++i) {
+                const Node& node = run.nodes[i];
+                if (node.target == kNoSymbol) {
+                    response.add_value(node.value);
+                } else {
+                    vars[node.target] = node.value;
+                    response.add_assignment(run.tokens[node.stmt->first].variable_name, node.value);
+                }
+            }
+        }
+
+        if (failed != kNoError) {
+            vars.symbols().truncate(run.nodes[failed].symbols_before);
+            throw std::runtime_error("Error in '" + std::string(run.nodes[failed].stmt->text) + "': " +
+                                     run.nodes[failed].error);
+        }
+    }
+
+private:
+    template <typename Fn>
+    void for_each_chunk(Run& run, size_t count, Fn fn) {
+        size_t chunks = std::min(count, pool_->size() * 4);
+        if (chunks == 0) return;
+        size_t chunk_size = (count + chunks - 1) / chunks;
+        for (size_t begin = 0; begin < count; begin += chunk_size) {
+            size_t end = std::min(begin + chunk_size, count);
+            pool_->submit([&run, fn, begin, end] {
+                TraceContextScope scope(run.trace);
+                fn(begin, end);
+            });
+        }
+    }
+
+    static void analyze_node(Run& run, const std::vector<Statement>& statements,
+                             const SymbolTable& symbols, size_t index) {
+        Node& node = run.nodes[index];
+        node.stmt = &statements[index];
+
+        // Ошибка разбора выдаётся при выполнении оператора
+        if (node.stmt->error.empty()) {
+            node.assigns = Calculator::analyze(run.tokens + node.stmt->first,
+                                               run.tokens + node.stmt->last, symbols);
+        }
+    }
+
+    static void link_graph(Run& run, VariableStore& vars, std::vector<size_t>& roots) {
+        // Последний присвоивший оператор по id переменной. Id плотные и не
+        // превышают размер таблицы сессии, поэтому это массив; после прохода
+        // сбрасываются только заполненные ячейки.
+        thread_local std::vector<size_t> last_writer;
+        run.inputs.reserve(run.nodes.size());
+
+        SymbolTable& symbols = vars.symbols();
+        size_t symbol_count = symbols.size();
+
+        for (size_t i = 0; i < run.nodes.size(); ++i) {
+            Node& node = run.nodes[i];
+            node.first_input = run.inputs.size();
+            node.symbols_before = symbol_count;
+
+            size_t pending = 0;
+            Token* token = run.tokens + node.stmt->first + (node.assigns ? 2 : 0);
+            Token* end = node.stmt->error.empty() ? run.tokens + node.stmt->last : token;
+            for (; token != end; ++token) {
+                if (token->type != TokenType::Variable) continue;
+
+                // Имя, которое присваивает более ранний оператор, при
+                // анализе ещё не было зарегистрировано
+                if (token->symbol == kNoSymbol) {
+                    token->symbol = symbols.lookup(token->variable_name);
+                }
+                SymbolId symbol = token->symbol;
+
+                bool seen = std::any_of(run.inputs.begin() + node.first_input, run.inputs.end(),
+                                        [&](const Input& in) { return in.symbol == symbol; });
+                if (seen) continue;
+
+                Input input;
+                input.symbol = symbol;
+                size_t writer = symbol < last_writer.size() ? last_writer[symbol] : kFromSession;
+                if (writer != kFromSession) {
+                    input.source = writer;
+                    run.nodes[writer].dependents.push_back(i);
+                    ++pending;
+                } else {
+                    const double* value = vars.find(symbol);
+                    input.present = value != nullptr;
+                    if (input.present) input.value = *value;
+                }
+                run.inputs.push_back(input);
+            }
+            node.last_input = run.inputs.size();
+
+            node.pending.store(pending, std::memory_order_relaxed);
+            if (pending == 0) roots.push_back(i);
+
+            // Цель регистрируется после чтений: в "x = x + 1" правая часть
+            // читает прежнее значение x
+            if (node.assigns) {
+                Token& target = run.tokens[node.stmt->first];
+                node.target = target.symbol = symbols.intern(target.variable_name);
+                if (node.target == symbol_count) ++symbol_count;
+                if (node.target >= last_writer.size()) last_writer.resize(node.target + 1, kFromSession);
+                last_writer[node.target] = i;
+            }
+        }
+
+        for (const Node& node : run.nodes) {
+            if (node.target != kNoSymbol) last_writer[node.target] = kFromSession;
+        }
+    }
+
+    void execute(Run& run, size_t index) {
+        // Готовых потомков, кроме одного, отдаём пулу; один выполняем сразу
+        while (index != kNoError) {
+            Node& node = run.nodes[index];
+            bool ok = false;
+
+            if (!node.blocked.load(std::memory_order_relaxed) &&
+                index < run.first_error.load(std::memory_order_relaxed)) {
+                ok = evaluate_node(run, node, index);
+            }
+
+            size_t next = kNoError;
+            for (size_t dependent : node.dependents) {
+                Node& child = run.nodes[dependent];
+                if (!ok) child.blocked.store(true, std::memory_order_relaxed);
+                if (child.pending.fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+
+                if (next == kNoError) {
+                    next = dependent;
+                } else {
+                    pool_->submit([this, &run, dependent] {
+                        TraceContextScope scope(run.trace);
+                        execute(run, dependent);
+                    });
+                }
+            }
+
+            run.executed.count_down();
+            index = next;
+        }
+    }
+
+    static bool evaluate_node(Run& run, Node& node, size_t index) {
+        TraceSpan span("calculate", static_cast<int64_t>(index));
+        try {
+            // Окружение оператора переиспользуется потоком: после первых
+            // операторов clear() и вставки входов обходятся без аллокаций
+            thread_local VariableStore env;
+            env.clear();
+            for (size_t i = node.first_input; i < node.last_input; ++i) {
+                const Input& input = run.inputs[i];
+                if (input.source != kFromSession) {
+                    env[input.symbol] = run.nodes[input.source].value;
+                } else if (input.present) {
+                    env[input.symbol] = input.value;
+                }
+            }
+
+            if (!node.stmt->error.empty()) throw std::runtime_error(node.stmt->error);
+            thread_local Calculator calc;
+            node.value = calc.calculate(run.tokens + node.stmt->first,
+                                        run.tokens + node.stmt->last, env);
+            return true;
+        } catch (const std::exception& e) {
+            node.error = e.what();
+            size_t current = run.first_error.load(std::memory_order_relaxed);
+            while (index < current &&
+                   !run.first_error.compare_exchange_weak(current, index, std::memory_order_acq_rel)) {
+            }
+            return false;
+        }
+    }
+};
+
+} // namespace calcserver
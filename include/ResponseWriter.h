@@ -0,0 +1,148 @@
+#pragma once
+#include <charconv>
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <nlohmann/json.hpp>
+
+namespace calcserver {
+
+// Печатает double по правилам nlohmann::json::dump() (1.0, 0.001, 1e+16,
+// 1.5e-05), но цифры берёт из std::to_chars — кратчайшие обратимые.
+// Grisu2 в nlohmann изредка выдаёт на цифру больше; оба варианта
+// читаются в одно и то же значение.
+inline void append_double(std::string& out, double value) {
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    if (value == 0) {
+        out += std::signbit(value) ? "-0.0" : "0.0";
+        return;
+    }
+
+    // to_chars даёт кратчайшие цифры в виде [-]d[.ddd]e±XX
+    char sci[32];
+    char* end = std::to_chars(sci, sci + sizeof(sci), value, std::chars_format::scientific).ptr;
+    const char* p = sci;
+    if (*p == '-') {
+        out += '-';
+        ++p;
+    }
+
+    char digits[20];
+    int len = 0;
+    for (; *p != 'e'; ++p) {
+        if (*p != '.') digits[len++] = *p;
+    }
+    int exponent = 0;
+    std::from_chars(p + (p[1] == '+' ? 2 : 1), end, exponent);
+
+    // Позиция десятичной точки относительно первой цифры
+    const int n = exponent + 1;
+    constexpr int kMinExp = -4;
+    constexpr int kMaxExp = 15;
+
+    if (len <= n && n <= kMaxExp) {
+        out.append(digits, len);
+        out.append(n - len, '0');
+        out += ".0";
+    } else if (0 < n && n <= kMaxExp) {
+        out.append(digits, n);
+        out += '.';
+        out.append(digits + n, len - n);
+    } else if (kMinExp < n && n <= 0) {
+        out += "0.";
+        out.append(-n, '0');
+        out.append(digits, len);
+    } else {
+        out += digits[0];
+        if (len > 1) {
+            out += '.';
+            out.append(digits + 1, len - 1);
+        }
+        int e = n - 1;
+        out += 'e';
+        out += e < 0 ? '-' : '+';
+        if (e < 0) e = -e;
+        if (e < 10) out += '0';
+        char exp_buf[4];
+        out.append(exp_buf, std::to_chars(exp_buf, exp_buf + sizeof(exp_buf), e).ptr);
+    }
+}
+
+inline void append_string(std::string& out, std::string_view s) {
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    for (char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out += "\\u00";
+                    out += hex[(c >> 4) & 0xF];
+                    out += hex[c & 0xF];
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+// =============================================
+// Response Writer
+// =============================================
+// Собирает тело ответа прямо в буфер, минуя json DOM. Формат тот же,
+// что у json{{"res", results}}.dump(). Буфер переиспользуется
+// между запросами, поэтому после прогрева запись не аллоцирует.
+class ResponseWriter {
+    std::string buffer_;
+    bool first_ = true;
+
+public:
+    void clear() {
+        buffer_.clear();
+        first_ = true;
+    }
+
+    void begin_results() {
+        buffer_ += "{\"res\":[";
+        first_ = true;
+    }
+
+    void add_value(double value) {
+        separate();
+        append_double(buffer_, value);
+    }
+
+    void add_assignment(std::string_view name, double value) {
+        separate();
+        buffer_ += '{';
+        append_string(buffer_, name);
+        buffer_ += ':';
+        append_double(buffer_, value);
+        buffer_ += '}';
+    }
+
+    void end_results() { buffer_ += "]}"; }
+
+    // Общий путь для ответов, не являющихся списком результатов
+    void write_json(const nlohmann::json& response) { buffer_ = response.dump(); }
+
+    const std::string& str() const { return buffer_; }
+
+private:
+    void separate() {
+        if (!first_) buffer_ += ',';
+        first_ = false;
+    }
+};
+
+} // namespace calcserver
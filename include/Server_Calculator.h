@@ -3,9 +3,13 @@
 #include <nlohmann/json.hpp>
 #include <memory>
 #include <mutex>
-#include <sstream>
 #include "SessionManager.h"
 #include "Calculator.h"
+#include "Compression.h"
+#include "Lexer.h"
+#include "ParallelEvaluator.h"
+#include "ResponseWriter.h"
+#include "Tracer.h"
 
 namespace calcserver {
 
@@ -26,7 +30,7 @@ public:
     }
 
     virtual bool handle(const json& request, 
-                       json& response,
+                       ResponseWriter& response,
                        SessionManager& session_manager,
                        const std::string& user) = 0;
 };
@@ -34,13 +38,13 @@ public:
 class CleanCommandHandler : public IRequestHandler {
 public:
     bool handle(const json& request, 
-               json& response,
+               ResponseWriter& response,
                SessionManager& session_manager,
                const std::string& user) override 
     {
         if (request.contains("cmd") && request["cmd"] == "clean") {
             session_manager.clear_session(user);
-            response["res"] = "OK";
+            response.write_json({{"res", "OK"}});
             return true;
         }
         return next_ ? next_->handle(request, response, session_manager, user) : false;
@@ -48,48 +52,93 @@ public:
 };
 
 class ExpressionHandler : public IRequestHandler {
+    ParallelConfig config_;
+    std::shared_ptr<ParallelEvaluator> parallel_;
+
 public:
+    explicit ExpressionHandler(ParallelConfig config = {}) : config_(config) {
+        if (config_.threads > 1) {
+            parallel_ = std::make_shared<ParallelEvaluator>(
+                std::make_shared<ThreadPool>(config_.threads));
+        }
+    }
+
     bool handle(const json& request, 
-               json& response,
+               ResponseWriter& response,
                SessionManager& session_manager,
                const std::string& user) override 
     {
         if (request.contains("exp")) {
-            auto& vars = session_manager.get_session(user);
-            Calculator calc;
-            json results = json::array();
-            std::istringstream iss(request["exp"].get<std::string>());
-            std::string line;
-            bool has_result = false;
-
-            while (std::getline(iss, line, ';')) {
-                line = Calculator::trim(line);
-                if (line.empty()) continue;
-
-                try {
-                    double result = calc.calculate(line, vars);
-                    has_result = true;
-
-                    // Формируем результат в зависимости от типа операции
-                    if (calc.was_assignment()) {
-                        results.push_back({{calc.get_last_var(), result}});
-                    } else {
-                        results.push_back(result);
-                    }
-                } catch (const std::exception& e) {
-                    throw std::runtime_error("Error in '" + line + "': " + e.what());
-                }
+            auto& vars = [&]() -> VariableStore& {
+                TraceSpan span("session_lookup");
+                return session_manager.get_session(user);
+            }();
+
+            // Буферы разбора живут в потоке и переиспользуются между запросами
+            thread_local std::vector<Statement> statements;
+            thread_local std::vector<Token> tokens;
+            statements.clear();
+            tokens.clear();
+            {
+                TraceSpan span("lex");
+                Lexer lexer(request["exp"].get_ref<const std::string&>());
+                Statement stmt;
+                while (lexer.next(stmt, tokens)) statements.push_back(stmt);
             }
 
-            if (!has_result) {
+            if (statements.empty()) {
                 throw std::runtime_error("No valid expressions");
             }
 
-            response["res"] = results;
+            response.begin_results();
+            if (parallel_ && statements.size() >= config_.min_statements) {
+                parallel_->evaluate(statements, tokens, vars, response);
+            } else {
+                evaluate_sequential(statements, tokens, vars, response);
+            }
+            response.end_results();
             return true;
         }
         return false;
     }
+
+private:
+    static void evaluate_sequential(const std::vector<Statement>& statements,
+                                    const std::vector<Token>& tokens,
+                                    VariableStore& vars,
+                                    ResponseWriter& response)
+    {
+        Calculator calc;
+        for (size_t i = 0; i < statements.size(); ++i) {
+            const Statement& stmt = statements[i];
+            try {
+                TraceSpan span("calculate", static_cast<int64_t>(i));
+                if (!stmt.error.empty()) throw std::runtime_error(stmt.error);
+                double result = calc.calculate(tokens.data() + stmt.first,
+                                               tokens.data() + stmt.last, vars);
+
+                // Формируем результат в зависимости от типа операции
+                if (calc.was_assignment()) {
+                    response.add_assignment(calc.get_last_var(), result);
+                } else {
+                    response.add_value(result);
+                }
+            } catch (const std::exception& e) {
+                throw std::runtime_error("Error in '" + std::string(stmt.text) + "': " + e.what());
+            }
+        }
+    }
+};
+
+// =============================================
+// Transport settings
+// =============================================
+struct TransportConfig {
+    compression::CompressionConfig compression;
+    // Keep-alive: пакетные клиенты шлют запросы подряд (в том числе
+    // конвейером) по одному соединению; httplib обрабатывает их по порядку
+    size_t keep_alive_max_count = 1000;
+    time_t keep_alive_timeout_sec = 30;
 };
 
 // =============================================
@@ -99,11 +148,24 @@ class CalculatorService {
     httplib::Server server_;
     std::shared_ptr<SessionManager> session_manager_;
     std::shared_ptr<IRequestHandler> request_chain_;
+    TraceConfig trace_config_;
+    ParallelConfig parallel_config_;
+    TransportConfig transport_config_;
     
 public:
-    CalculatorService(std::shared_ptr<SessionManager> session_manager)
-        : session_manager_(session_manager)
+    CalculatorService(std::shared_ptr<SessionManager> session_manager,
+                      TraceConfig trace_config = {},
+                      ParallelConfig parallel_config = {},
+                      TransportConfig transport_config = {})
+        : session_manager_(session_manager),
+          trace_config_(std::move(trace_config)),
+          parallel_config_(parallel_config),
+          transport_config_(transport_config)
     {
+        compression::validate(transport_config_.compression);
+        Tracer::instance().configure(trace_config_);
+        server_.set_keep_alive_max_count(transport_config_.keep_alive_max_count);
+        server_.set_keep_alive_timeout(transport_config_.keep_alive_timeout_sec);
         build_handler_chain();
         setup_routes();
     }
@@ -116,24 +178,64 @@ public:
 private:
     void build_handler_chain() {
         auto clean_handler = std::make_shared<CleanCommandHandler>();
-        auto expr_handler = std::make_shared<ExpressionHandler>();
+        auto expr_handler = std::make_shared<ExpressionHandler>(parallel_config_);
         
         clean_handler->set_next(expr_handler);
         request_chain_ = clean_handler;
     }
 
+    // Сжимает крупные ответы, если клиент принимает gzip/zstd
+    void send_body(const httplib::Request& req, httplib::Response& res, const std::string& body) {
+        const auto& config = transport_config_.compression;
+        if (!config.enabled || body.size() < config.min_size) {
+            res.set_content(body, "application/json");
+            return;
+        }
+
+        res.set_header("Vary", "Accept-Encoding");
+        auto encoding = compression::negotiate(req.get_header_value("Accept-Encoding"));
+        if (encoding == compression::Encoding::Identity) {
+            res.set_content(body, "application/json");
+            return;
+        }
+
+        // Скрипт к этому моменту уже выполнен и сессия изменена: при сбое
+        // сжатия ответ уходит несжатым, а не ошибкой 400
+        thread_local std::string compressed;
+        try {
+            TraceSpan span("compress", static_cast<int64_t>(body.size()));
+            compression::compress(encoding, body, compressed, config);
+        } catch (const std::exception&) {
+            res.set_content(body, "application/json");
+            return;
+        }
+        res.set_header("Content-Encoding", compression::encoding_name(encoding));
+        res.set_content(compressed, "application/json");
+    }
+
     void setup_routes() {
         server_.Post("/api/calculate", [&](const httplib::Request& req, httplib::Response& res) {
+            TraceRequest trace(!trace_config_.force_header.empty() &&
+                               req.has_header(trace_config_.force_header));
             try {
-                json request = json::parse(req.body);
-                json response;
+                json request;
+                {
+                    TraceSpan span("json_parse");
+                    request = json::parse(req.body);
+                }
+                // Буфер ответа живёт в потоке и переиспользуется между запросами
+                thread_local ResponseWriter response;
+                response.clear();
                 std::string user = request.value("user", "default");
                 
                 if (!request_chain_->handle(request, response, *session_manager_, user)) {
                     throw std::runtime_error("Unsupported request format");
                 }
                 
-                res.set_content(response.dump(), "application/json");
+                // Результаты уже записаны в ResponseWriter внутри "calculate" (или "commit");
+                // здесь только передача тела в httplib и сжатие
+                TraceSpan span("send");
+                send_body(req, res, response.str());
                 
             } catch (const std::exception& e) {
                 res.status = 400;
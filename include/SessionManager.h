@@ -2,14 +2,20 @@
 #include <map>
 #include <mutex>
 #include <string>
+#include "Tracer.h"
+#include "VariableStore.h"
 
 class SessionManager {
-    std::map<std::string, std::map<std::string, double>> sessions_;
+    std::map<std::string, VariableStore> sessions_;
     mutable std::mutex mtx_;
 
 public:
-    std::map<std::string, double>& get_session(const std::string& user) {
-        std::lock_guard<std::mutex> lock(mtx_);
+    VariableStore& get_session(const std::string& user) {
+        std::unique_lock<std::mutex> lock(mtx_, std::defer_lock);
+        {
+            calcserver::TraceSpan span("lock_wait");
+            lock.lock();
+        }
         return sessions_[user];
     }
 
@@ -1,5 +1,6 @@
 #pragma once
-#include <string>
+#include <string_view>
+#include "VariableStore.h"
 
 enum class TokenType {
     Number,
@@ -14,10 +15,11 @@ struct Token {
     TokenType type;
     double number_value;
     char operator_symbol;
-    std::string variable_name;
+    std::string_view variable_name;   // Указывает в текст запроса
+    SymbolId symbol = kNoSymbol;      // Заполняется при анализе или вычислении, не лексером
 
     Token(double val) : type(TokenType::Number), number_value(val) {}
     Token(char op) : type(TokenType::Operator), operator_symbol(op) {}
     Token(TokenType t) : type(t) {}
-    Token(std::string var) : type(TokenType::Variable), variable_name(var) {}
+    Token(std::string_view var) : type(TokenType::Variable), variable_name(var) {}
 };
\ No newline at end of file
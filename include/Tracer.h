@@ -0,0 +1,312 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace calcserver {
+
+// =============================================
+// Trace configuration
+// =============================================
+struct TraceConfig {
+    bool enabled = false;                          // Без него трассировка полностью выключена
+    double sample_rate = 0.0;                      // Доля запросов в трассе (0 — только по заголовку)
+    std::string output_path = "calc_trace.json";   // Файл в формате Chrome trace-event
+    std::string force_header = "X-Calc-Trace";     // Заголовок, принудительно включающий трассировку
+    size_t ring_capacity = 4096;                   // Размер кольцевого буфера потока (степень двойки)
+    std::chrono::milliseconds flush_interval{200}; // Период фоновой выгрузки
+};
+
+// Завершённый интервал. Имя — строковый литерал, поэтому запись не аллоцирует.
+struct SpanRecord {
+    const char* name;
+    uint64_t request_id;
+    int64_t begin_us;
+    int64_t duration_us;
+    int64_t arg;
+};
+
+// =============================================
+// Per-thread ring buffer (single producer / single consumer)
+// =============================================
+class SpanRing {
+    std::vector<SpanRecord> slots_;
+    size_t mask_;
+    std::atomic<uint64_t> head_{0};   // Пишет только поток-владелец
+    std::atomic<uint64_t> tail_{0};   // Пишет только поток выгрузки
+    std::atomic<uint64_t> dropped_{0};
+    uint32_t tid_;
+
+public:
+    SpanRing(size_t capacity, uint32_t tid) : tid_(tid) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    uint32_t tid() const { return tid_; }
+
+    void push(const SpanRecord& record) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) > mask_) {
+            // Буфер полон — теряем интервал, но не блокируем запрос
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        slots_[head & mask_] = record;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    template <typename Fn>
+    void drain(Fn&& fn) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            fn(slots_[tail & mask_]);
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+    uint64_t take_dropped() { return dropped_.exchange(0, std::memory_order_relaxed); }
+};
+
+// Контекст трассировки текущего потока; передаётся в рабочие потоки явно
+struct TraceContext {
+    bool active = false;
+    uint64_t request_id = 0;
+};
+
+// =============================================
+// Tracer: ring registry + background flusher
+// =============================================
+class Tracer {
+    TraceConfig config_;
+    std::atomic<bool> enabled_{false};
+    std::atomic<uint64_t> next_request_id_{1};
+    const std::chrono::steady_clock::time_point epoch_ = std::chrono::steady_clock::now();
+
+    std::mutex rings_mtx_;
+    std::vector<std::shared_ptr<SpanRing>> rings_;
+    uint32_t next_tid_ = 1;
+
+    std::mutex flush_mtx_;
+    std::condition_variable flush_cv_;
+    std::thread flusher_;
+    bool stopping_ = false;
+    std::ofstream out_;
+    bool first_event_ = true;
+
+    Tracer() = default;
+
+public:
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    ~Tracer() { shutdown(); }
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    // Запускает фоновую выгрузку. Вызывается один раз при старте сервиса.
+    void configure(const TraceConfig& config) {
+        shutdown();
+        config_ = config;
+        if (!config_.enabled) return;
+
+        out_.open(config_.output_path, std::ios::out | std::ios::trunc);
+        if (!out_) return;
+        out_ << "[\n";
+        first_event_ = true;
+        stopping_ = false;
+        flusher_ = std::thread([this] { flush_loop(); });
+        enabled_.store(true, std::memory_order_release);
+    }
+
+    void shutdown() {
+        if (!flusher_.joinable()) return;
+        enabled_.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(flush_mtx_);
+            stopping_ = true;
+        }
+        flush_cv_.notify_one();
+        flusher_.join();
+        // Последняя выгрузка: поток мог завершиться, не дойдя до ожидания,
+        // или пропустить интервалы, записанные во время flush_rings()
+        flush_rings();
+        out_ << "\n]\n";
+        out_.close();
+    }
+
+    const TraceConfig& config() const { return config_; }
+
+    // Решение о сэмплировании принимается один раз на запрос
+    bool should_trace(bool forced) {
+        if (!enabled_.load(std::memory_order_relaxed)) return false;
+        if (forced) return true;
+        if (config_.sample_rate <= 0.0) return false;
+        if (config_.sample_rate >= 1.0) return true;
+
+        thread_local uint64_t state = 0x9E3779B97F4A7C15ull ^
+            reinterpret_cast<uintptr_t>(&state);
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<double>(state >> 11) * 0x1.0p-53 < config_.sample_rate;
+    }
+
+    uint64_t next_request_id() {
+        return next_request_id_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    int64_t now_us() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - epoch_).count();
+    }
+
+    static TraceContext& current() {
+        thread_local TraceContext context;
+        return context;
+    }
+
+    void record(const SpanRecord& record) {
+        thread_local std::shared_ptr<SpanRing> ring;
+        if (!ring) ring = register_ring();
+        ring->push(record);
+    }
+
+private:
+    std::shared_ptr<SpanRing> register_ring() {
+        std::lock_guard<std::mutex> lock(rings_mtx_);
+        auto ring = std::make_shared<SpanRing>(config_.ring_capacity, next_tid_++);
+        rings_.push_back(ring);
+        return ring;
+    }
+
+    void flush_loop() {
+        std::unique_lock<std::mutex> lock(flush_mtx_);
+        while (!stopping_) {
+            flush_cv_.wait_for(lock, config_.flush_interval, [this] { return stopping_; });
+            lock.unlock();
+            flush_rings();
+            lock.lock();
+        }
+    }
+
+    void flush_rings() {
+        std::vector<std::shared_ptr<SpanRing>> rings;
+        {
+            std::lock_guard<std::mutex> lock(rings_mtx_);
+            rings = rings_;
+        }
+
+        for (auto& ring : rings) {
+            uint32_t tid = ring->tid();
+            ring->drain([&](const SpanRecord& span) {
+                write_event(span, tid);
+            });
+            if (uint64_t dropped = ring->take_dropped()) {
+                SpanRecord marker{"dropped_spans", 0, now_us(), 0, static_cast<int64_t>(dropped)};
+                write_event(marker, tid);
+            }
+        }
+        out_.flush();
+    }
+
+    void write_event(const SpanRecord& span, uint32_t tid) {
+        if (!first_event_) out_ << ",\n";
+        first_event_ = false;
+        out_ << "{\"name\":\"" << span.name
+             << "\",\"cat\":\"calc\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+             << ",\"ts\":" << span.begin_us
+             << ",\"dur\":" << span.duration_us
+             << ",\"args\":{\"req\":" << span.request_id
+             << ",\"arg\":" << span.arg << "}}";
+    }
+};
+
+// =============================================
+// RAII helpers
+// =============================================
+
+// Интервал внутри трассируемого запроса. Без активной трассировки —
+// одна проверка thread_local флага.
+class TraceSpan {
+    const char* name_;
+    int64_t begin_us_ = 0;
+    int64_t arg_;
+    bool active_;
+
+public:
+    explicit TraceSpan(const char* name, int64_t arg = 0)
+        : name_(name), arg_(arg), active_(Tracer::current().active)
+    {
+        if (active_) begin_us_ = Tracer::instance().now_us();
+    }
+
+    ~TraceSpan() {
+        if (!active_) return;
+        Tracer& tracer = Tracer::instance();
+        tracer.record({name_, Tracer::current().request_id, begin_us_,
+                       tracer.now_us() - begin_us_, arg_});
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+// Переносит контекст запроса в рабочий поток на время задачи
+class TraceContextScope {
+    TraceContext saved_;
+
+public:
+    explicit TraceContextScope(const TraceContext& context) : saved_(Tracer::current()) {
+        Tracer::current() = context;
+    }
+
+    ~TraceContextScope() { Tracer::current() = saved_; }
+
+    TraceContextScope(const TraceContextScope&) = delete;
+    TraceContextScope& operator=(const TraceContextScope&) = delete;
+};
+
+// Включает трассировку для запроса (с учётом сэмплирования) и пишет
+// охватывающий интервал "request".
+class TraceRequest {
+    TraceContext saved_;
+    bool active_;
+    int64_t begin_us_ = 0;
+
+public:
+    explicit TraceRequest(bool forced)
+        : saved_(Tracer::current()), active_(Tracer::instance().should_trace(forced))
+    {
+        if (!active_) return;
+        Tracer& tracer = Tracer::instance();
+        Tracer::current() = {true, tracer.next_request_id()};
+        begin_us_ = tracer.now_us();
+    }
+
+    ~TraceRequest() {
+        if (!active_) return;
+        Tracer& tracer = Tracer::instance();
+        tracer.record({"request", Tracer::current().request_id, begin_us_,
+                       tracer.now_us() - begin_us_, 0});
+        Tracer::current() = saved_;
+    }
+
+    TraceRequest(const TraceRequest&) = delete;
+    TraceRequest& operator=(const TraceRequest&) = delete;
+};
+
+} // namespace calcserver
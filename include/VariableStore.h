@@ -0,0 +1,224 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using SymbolId = uint32_t;
+constexpr SymbolId kNoSymbol = std::numeric_limits<SymbolId>::max();
+
+// =============================================
+// Symbol Table
+// =============================================
+// Таблица имён переменных одной сессии (см. VariableStore). Id плотные и
+// выдаются по порядку, строки хранятся в deque и не переезжают, поэтому
+// name() можно отдавать как string_view. Таблица живёт и очищается вместе
+// с сессией, так что число имён ограничено её переменными.
+class SymbolTable {
+    std::deque<std::string> names_;
+    std::unordered_map<std::string_view, SymbolId> ids_;
+    std::atomic<uint64_t> serial_{next_serial()};   // Меняется при удалении имён
+    mutable std::shared_mutex mtx_;
+
+    // Запись кэша потока: таблица, имя (string_view в names_) и его id
+    struct Entry {
+        uint64_t table = 0;
+        std::string_view name;
+        SymbolId id = kNoSymbol;
+    };
+
+public:
+    SymbolTable() = default;
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(mtx_);
+        return names_.size();
+    }
+
+    SymbolId intern(std::string_view name) {
+        Entry& entry = cached(name);
+        if (entry.table == serial_.load(std::memory_order_relaxed) && entry.name == name) return entry.id;
+
+        entry = intern_shared(name);
+        return entry.id;
+    }
+
+    // Поиск без регистрации нового имени
+    SymbolId lookup(std::string_view name) const {
+        Entry& entry = cached(name);
+        if (entry.table == serial_.load(std::memory_order_relaxed) && entry.name == name) return entry.id;
+
+        Entry found = lookup_shared(name);
+        if (found.id != kNoSymbol) entry = found;
+        return found.id;
+    }
+
+    std::string_view name(SymbolId id) const {
+        std::shared_lock<std::shared_mutex> lock(mtx_);
+        return names_[id];
+    }
+
+    // Удаляет имена с id >= size. Вызывается, когда никто не ищет имена
+    // в этой таблице; записи кэшей потоков устаревают вместе с serial_.
+    void truncate(size_t size) {
+        std::unique_lock<std::shared_mutex> lock(mtx_);
+        if (size >= names_.size()) return;
+
+        if (size == 0) {
+            // Очистка сессии: память отдаётся целиком
+            std::deque<std::string>().swap(names_);
+            std::unordered_map<std::string_view, SymbolId>().swap(ids_);
+        } else {
+            while (names_.size() > size) {
+                ids_.erase(names_.back());
+                names_.pop_back();
+            }
+        }
+        serial_.store(next_serial(), std::memory_order_relaxed);
+    }
+
+    void clear() { truncate(0); }
+
+private:
+    static uint64_t next_serial() {
+        static std::atomic<uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    // Кэш потока перед таблицей: повторные имена без блокировки. Один кэш
+    // на все таблицы, запись действительна, пока совпадает serial_.
+    static Entry& cached(std::string_view name) {
+        thread_local std::array<Entry, 1024> cache;
+        return cache[std::hash<std::string_view>{}(name) & (cache.size() - 1)];
+    }
+
+    Entry lookup_shared(std::string_view name) const {
+        std::shared_lock<std::shared_mutex> lock(mtx_);
+        auto it = ids_.find(name);
+        if (it == ids_.end()) return {};
+        return {serial_.load(std::memory_order_relaxed), it->first, it->second};
+    }
+
+    Entry intern_shared(std::string_view name) {
+        Entry found = lookup_shared(name);
+        if (found.id != kNoSymbol) return found;
+
+        std::unique_lock<std::shared_mutex> lock(mtx_);
+        auto it = ids_.find(name);
+        if (it != ids_.end()) return {serial_.load(std::memory_order_relaxed), it->first, it->second};
+
+        SymbolId id = static_cast<SymbolId>(names_.size());
+        names_.emplace_back(name);
+        ids_.emplace(names_.back(), id);
+        return {serial_.load(std::memory_order_relaxed), names_.back(), id};
+    }
+};
+
+// =============================================
+// Variable Store
+// =============================================
+// Переменные сессии: хеш-таблица с открытой адресацией по SymbolId,
+// значения лежат подряд в values_ в порядке добавления и не переезжают
+// при росте таблицы. Id выдаёт собственная таблица имён хранилища.
+class VariableStore {
+    struct Entry {
+        SymbolId id;
+        uint32_t slot;
+    };
+
+    std::vector<Entry> table_;
+    std::vector<SymbolId> keys_;
+    std::vector<double> values_;
+    SymbolTable symbols_;
+
+public:
+    static constexpr uint32_t kNotFound = std::numeric_limits<uint32_t>::max();
+
+    SymbolTable& symbols() { return symbols_; }
+    const SymbolTable& symbols() const { return symbols_; }
+
+    size_t size() const { return keys_.size(); }
+    bool empty() const { return keys_.empty(); }
+
+    uint32_t find_slot(SymbolId id) const {
+        if (table_.empty() || id == kNoSymbol) return kNotFound;
+        size_t mask = table_.size() - 1;
+        for (size_t pos = hash(id) & mask;; pos = (pos + 1) & mask) {
+            if (table_[pos].id == id) return table_[pos].slot;
+            if (table_[pos].id == kNoSymbol) return kNotFound;
+        }
+    }
+
+    const double* find(SymbolId id) const {
+        uint32_t slot = find_slot(id);
+        return slot == kNotFound ? nullptr : &values_[slot];
+    }
+
+    double* find(SymbolId id) {
+        uint32_t slot = find_slot(id);
+        return slot == kNotFound ? nullptr : &values_[slot];
+    }
+
+    const double* find(std::string_view name) const {
+        SymbolId id = symbols_.lookup(name);
+        return id == kNoSymbol ? nullptr : find(id);
+    }
+
+    double& operator[](SymbolId id) {
+        uint32_t slot = find_slot(id);
+        if (slot != kNotFound) return values_[slot];
+
+        if ((keys_.size() + 1) * 2 > table_.size()) {
+            rehash(table_.empty() ? 16 : table_.size() * 2);
+        }
+        slot = static_cast<uint32_t>(keys_.size());
+        keys_.push_back(id);
+        values_.push_back(0.0);
+        place(id, slot);
+        return values_[slot];
+    }
+
+    double& operator[](std::string_view name) {
+        return (*this)[symbols_.intern(name)];
+    }
+
+    void clear() {
+        std::fill(table_.begin(), table_.end(), Entry{kNoSymbol, 0});
+        keys_.clear();
+        values_.clear();
+        symbols_.clear();
+    }
+
+    const std::vector<SymbolId>& keys() const { return keys_; }
+    const std::vector<double>& values() const { return values_; }
+
+private:
+    static size_t hash(SymbolId id) {
+        // Фибоначчиево хеширование: последовательные id расходятся по таблице
+        return static_cast<size_t>((static_cast<uint64_t>(id) * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    void place(SymbolId id, uint32_t slot) {
+        size_t mask = table_.size() - 1;
+        size_t pos = hash(id) & mask;
+        while (table_[pos].id != kNoSymbol) pos = (pos + 1) & mask;
+        table_[pos] = {id, slot};
+    }
+
+    void rehash(size_t capacity) {
+        table_.assign(capacity, Entry{kNoSymbol, 0});
+        for (uint32_t slot = 0; slot < keys_.size(); ++slot) {
+            place(keys_[slot], slot);
+        }
+    }
+};
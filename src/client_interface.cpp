@@ -3,6 +3,7 @@
 #include <httplib.h>
 #include <nlohmann/json.hpp>
 #include "../include/Calculator.h"
+#include "../include/Calc_Client.h"
 
 using json = nlohmann::json;
 
@@ -33,8 +34,10 @@ int main(int argc, char* argv[]) {
         req["user"] = user;
     }
 
-    httplib::Client cli("localhost", 8080);
-    if (auto res = cli.Post("/api/calculate", req.dump(), "application/json")) {
+    // Запрос объявляет поддерживаемые кодировки, ответ приходит распакованным
+    auto cli = calcclient::make_client();
+
+    if (auto res = calcclient::post_request(cli, req)) {
         auto j = json::parse(res->body);
         if (j.contains("res")) std::cout << j["res"] << "\n";
         if (j.contains("error")) std::cerr << "Error: " << j["error"] << "\n";
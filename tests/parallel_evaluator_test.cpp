@@ -0,0 +1,157 @@
+// Сравнение параллельного и последовательного вычисления скриптов.
+// Оба пути ExpressionHandler получают одни и те же скрипты в своих сессиях;
+// ответ, текст ошибки, переменные сессии и размер таблицы имён должны
+// совпадать. Запуск: ctest или ./build/parallel_evaluator_test
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/Server_Calculator.h"
+
+using namespace calcserver;
+
+struct Outcome {
+    std::string response;
+    std::string error;
+    std::map<std::string, double> vars;
+    size_t symbols = 0;
+
+    bool operator==(const Outcome& other) const {
+        return response == other.response && error == other.error &&
+               vars == other.vars && symbols == other.symbols;
+    }
+};
+
+static Outcome run(ExpressionHandler& handler, SessionManager& sessions, const std::string& script) {
+    Outcome outcome;
+    ResponseWriter response;
+    try {
+        handler.handle({{"exp", script}}, response, sessions, "user");
+        outcome.response = response.str();
+    } catch (const std::exception& e) {
+        outcome.error = e.what();
+    }
+
+    const VariableStore& vars = sessions.get_session("user");
+    for (size_t i = 0; i < vars.size(); ++i) {
+        outcome.vars[std::string(vars.symbols().name(vars.keys()[i]))] = vars.values()[i];
+    }
+    outcome.symbols = vars.symbols().size();
+    return outcome;
+}
+
+static void print(const Outcome& outcome) {
+    std::cerr << "  response: " << outcome.response << "\n  error: " << outcome.error
+              << "\n  symbols: " << outcome.symbols << "\n  vars:";
+    for (const auto& [name, value] : outcome.vars) std::cerr << " " << name << "=" << value;
+    std::cerr << "\n";
+}
+
+// Пара сессий, по которым идут оба пути
+class Differential {
+    ExpressionHandler sequential_;
+    ExpressionHandler parallel_;
+    SessionManager sequential_sessions_;
+    SessionManager parallel_sessions_;
+    int failures_ = 0;
+
+    static ParallelConfig sequential_config() {
+        ParallelConfig config;
+        config.threads = 0;
+        return config;
+    }
+
+    static ParallelConfig parallel_config() {
+        ParallelConfig config;
+        config.threads = 4;
+        config.min_statements = 1;   // Параллельно считается любой скрипт
+        return config;
+    }
+
+public:
+    Differential() : sequential_(sequential_config()), parallel_(parallel_config()) {}
+
+    void check(const std::string& script) {
+        Outcome expected = run(sequential_, sequential_sessions_, script);
+        Outcome actual = run(parallel_, parallel_sessions_, script);
+        if (expected == actual) return;
+
+        if (++failures_ <= 5) {
+            std::cerr << "Mismatch on: " << script << "\nsequential:\n";
+            print(expected);
+            std::cerr << "parallel:\n";
+            print(actual);
+        }
+    }
+
+    void clean() {
+        sequential_sessions_.clear_session("user");
+        parallel_sessions_.clear_session("user");
+    }
+
+    int failures() const { return failures_; }
+};
+
+static std::string random_script(std::mt19937& rng, int round) {
+    std::string script;
+    int count = 1 + rng() % 60;
+    for (int i = 0; i < count; ++i) {
+        std::string lhs = "a" + std::to_string(rng() % 8);
+        std::string rhs = "a" + std::to_string(rng() % 8);
+        switch (rng() % 10) {
+            case 0: case 1: case 2: case 3:
+                script += lhs + " = " + rhs + " + " + std::to_string(rng() % 5); break;
+            case 4:
+                script += lhs + " = " + lhs + " * 2"; break;
+            case 5: case 6:
+                script += lhs + " * (" + rhs + " - 1)"; break;
+            case 7:
+                script += lhs + " = 1 / (" + rhs + " - " + std::to_string(rng() % 4) + ")"; break;
+            case 8:
+                // Имя, которого ещё нет в таблице сессии
+                script += "n" + std::to_string(round) + "_" + std::to_string(i) + " = " + rhs; break;
+            default:
+                script += rng() % 20 == 0 ? lhs + " = $" : std::to_string(rng() % 100); break;
+        }
+        script += "; ";
+    }
+    return script;
+}
+
+int main() {
+    Differential test;
+
+    // Ошибки, зависимые от ошибочного оператора, и самоссылки
+    const std::vector<std::string> cases = {
+        "x = 2; y = x * 3; x + y",
+        "a = 1 / 0; b = a + 1; 5",
+        "a = 1; b = 1 / (a - 1); c = b + 1; d = 7",
+        "q = q + 1",
+        "q = 1; q = q + 1; q * 10",
+        "u = v; v = 1",
+        "w = 5; w",
+        "p = 1; r = $; s = p",
+        "m = (1 + 2; m",
+        "y = x + q; x = 1 / 0; z = x",
+        "k1 = 1; k2 = k1 + k1; k3 = k2 * k1; k1 = k3 - 1; k1 + k2 + k3",
+    };
+    for (const std::string& script : cases) test.check(script);
+    test.clean();
+
+    std::mt19937 rng(7);
+    for (int round = 0; round < 2000; ++round) {
+        if (round % 50 == 0) {
+            test.clean();
+            test.check("a0 = 1; a1 = 2");
+        }
+        test.check(random_script(rng, round));
+    }
+
+    if (test.failures() != 0) {
+        std::cerr << test.failures() << " scripts differ\n";
+        return 1;
+    }
+    std::cout << "parallel and sequential results match\n";
+    return 0;
+}